@@ -44,9 +44,39 @@ The code is made easy to understand. However, note that there are parts of the c
 #include <time.h>	// time handling library
 #include <string.h> // string handling library
 #include <stdbool.h> // true/false data type
-
-// Macros (remove "//" before "printf" for enable)
-#define DEBUG printf
+#include <math.h>	// log() for the scorer's probabilities
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h> // SIMD gathers for the scorer
+#define SCORE_AVX2 // the AVX2 scorer is built, and used if the CPU has it
+#endif
+
+// Macros (build with -DNO_DEBUG for remove them completely)
+// debug_enabled silences them at runtime, e.g. when generating big batches
+#ifdef NO_DEBUG
+#define DEBUG(...) ((void)0)
+#else
+#define DEBUG(...) do { if (debug_enabled) printf(__VA_ARGS__); } while (0)
+#endif
+
+static bool debug_enabled = true; // print every step of the name building
+
+// 20 chars for the name, +1 char for \0
+#define NAME_BUFFER_SIZE (20 + 1)
+
+// define most frequent syllables that start with a consonant
+static char* syllables_consonant[] = {"ba", "be", "bi", "bo", "bu", "da", "de",
+								"di", "do", "du", "la", "le", "li", "lo",
+								"lu", "ma", "me", "mi", "mo", "mu", "na",
+								"ne", "ni", "no", "nu", "pa", "pe", "pi",
+								"po", "pu", "ra", "re", "ri", "ro", "ru",
+								"sa", "se", "si", "so", "su", "ta", "te",
+								"ti", "to", "tu", "va", "liy","man","mar",
+								"vit", "ye", "tom", "lay", "fri", "rom",
+								"mor", "dal", "fre", "fro", "ch", "ha",
+								"je", "ja", "ju", "ga", "mon", "mir"};
+
+// define most frequent syllables that start with a vowel
+static char* syllables_vowel[] = {"oo", "imp", "um", "ius", "ip", "olf", "ali"};
 
 /***********************************************************************
 Makes sure that our string terminates with end character '\0'
@@ -60,10 +90,11 @@ void write_string_termination(char *name, int name_length)
 }
 
 /***********************************************************************
-Function for generating a random pronounceable person name without
-using a database
+Builds a random pronounceable person name into the given buffer, which
+must have room for NAME_BUFFER_SIZE characters. The random numbers' seed
+is not touched here, so many names can be built in a row
 ***********************************************************************/
-void generate_name()
+void build_name(char *name)
 {
 	// define and initialize the possible range for the name
 	int min_length = 3; // we don't want a name with less than 3 letters
@@ -78,17 +109,6 @@ void generate_name()
 	// actual name length
 	unsigned short name_length = 0; // count the characters inside name[]
 
-	// name characters array with dynamic memory allocation for 20 chars
-	// size, +1 char for \0
-	//char* name = (char*)malloc((length + 1) * sizeof(char)); // +1 for last '\0' char
-	char* name = (char*)malloc((20 + 1) * sizeof(char)); // reserve memory  for
-
-	if (name == NULL)
-	{
-		printf("ERROR: couldn't assign memory for name characters array\n");
-		exit(1);
-    }
-
 	// Initialize name as an empty string with \0 for string handling functions
 	name[0] = '\0';
 
@@ -97,28 +117,10 @@ void generate_name()
 	char consonants[] = "bcdfghjklmnpqrstvwxyz"; // Keep in mind that “Y”
 	// can sometimes function as a vowel (which is known as a semivowel).
 
-	// define most frequent syllables that start with a consonant
-	char* syllables_consonant[] = {"ba", "be", "bi", "bo", "bu", "da", "de",
-									"di", "do", "du", "la", "le", "li", "lo",
-									"lu", "ma", "me", "mi", "mo", "mu", "na",
-									"ne", "ni", "no", "nu", "pa", "pe", "pi",
-									"po", "pu", "ra", "re", "ri", "ro", "ru",
-									"sa", "se", "si", "so", "su", "ta", "te",
-									"ti", "to", "tu", "va", "liy","man","mar",
-									"vit", "ye", "tom", "lay", "fri", "rom",
-									"mor", "dal", "fre", "fro", "ch", "ha",
-									"je", "ja", "ju", "ga", "mon", "mir"};
-
-		// define most frequent syllables that start with a vowel
-	char* syllables_vowel[] = {"oo", "imp", "um", "ius", "ip", "olf", "ali"};
-
 	// vars for trigger double letters randomly
 	unsigned int probability = 0;
 	//unsigned int probability_result = 0;
 
-	// Initialize random numbers' seed
-	srand(time(NULL));
-
 	// count the WHILE loop runs (for debug only)
 	int temp_run_count = 0;
 	//int name_length = 0;
@@ -139,14 +141,14 @@ void generate_name()
 			// probability if to start with a vower or a consonant letter
 			if (temp_run_count == 0)
 			{
-				memset(name, '\0', sizeof(name)); // clears the whole string
+				memset(name, '\0', NAME_BUFFER_SIZE); // clears the whole string
 
 				if (rand() % 100 <=49) // if probability is between 0-49
 				{
 					name[name_length] = vowels[rand() % strlen(vowels)]; // add a vowel
 					DEBUG("We started the name with a vowel: %c\n", name[0]);
 				}
-				else if ( (rand() % 100 <=99) && (rand() % 100 >=50) ) // if probability is between 50 and 99
+				else // if probability is between 50 and 99
 				{
 					name[name_length] = consonants[rand() % strlen(consonants)]; // add a consonant
 					DEBUG("We started the name with a consonant: %c\n", name[0]);
@@ -566,10 +568,530 @@ void generate_name()
 	//write_string_termination(name, name_length);
 
 	DEBUG("\nGenerated name length after adding 0 at the end of the string: %d\n", name_length);
+}
+
+/***********************************************************************
+Function for generating a random pronounceable person name without
+using a database
+***********************************************************************/
+void generate_name()
+{
+	// name characters array with dynamic memory allocation for 20 chars
+	// size, +1 char for \0
+	char* name = (char*)malloc(NAME_BUFFER_SIZE * sizeof(char));
+
+	if (name == NULL)
+	{
+		printf("ERROR: couldn't assign memory for name characters array\n");
+		exit(1);
+	}
+
+	// Initialize random numbers' seed
+	srand(time(NULL));
+
+	build_name(name);
+
 	printf("\n\tGENERATED NAME RESULT: %s\n", name);
 	free(name); // clean the memory
 }
 
+/************************ PRONOUNCEABILITY SCORER **********************
+Ranks big batches of generated names by how pronounceable they look.
+
+ -A trigram table of log-probabilities is trained over the 26 letters
+ plus 1 word boundary symbol (so a name "bo" is read as "^^bo$").
+ -It's trained from a corpus file (one name per line) or, without it,
+ from the generator's own syllables joined in pairs.
+ -Trigram, bigram and single letter frequencies are mixed together
+ when the table is built, so scoring needs just 1 lookup per letter.
+ -A name's score is its average log-probability per trigram, so long
+ names are not punished just for being long. Higher is better.
+ -Names are packed one after another in NAME_BUFFER_SIZE slots. With
+ AVX2 we score 8 names at once using gathers, the rest one by one.
+ -"Best K of N" keeps the K highest scores with a partial select, so
+ we don't need to sort the whole batch.
+***********************************************************************/
+
+#define SCORE_SYMBOLS 27	// 26 letters + 1 word boundary symbol
+#define SCORE_BOUNDARY 26	// code of the word boundary symbol
+#define SCORE_CODE_STRIDE 32	// "^^" + 20 letters + "$" + room for 4 bytes reads
+
+// trigram table, indexed by a * 27 * 27 + b * 27 + c
+static float trigram_logp[SCORE_SYMBOLS * SCORE_SYMBOLS * SCORE_SYMBOLS];
+
+// n-gram counters used while training
+static unsigned int trigram_count[SCORE_SYMBOLS][SCORE_SYMBOLS][SCORE_SYMBOLS];
+static unsigned int bigram_count[SCORE_SYMBOLS][SCORE_SYMBOLS];
+static unsigned int unigram_count[SCORE_SYMBOLS];
+
+// a name together with its score, for the "best K of N" selection
+struct scored_name
+{
+	float score;
+	int index; // position of the name inside the packed batch
+};
+
+/***********************************************************************
+Converts a letter into its code 0-25, anything else is a word boundary
+***********************************************************************/
+int letter_code(char letter)
+{
+	if (letter >= 'a' && letter <= 'z')
+	{
+		return letter - 'a';
+	}
+	if (letter >= 'A' && letter <= 'Z')
+	{
+		return letter - 'A';
+	}
+	return SCORE_BOUNDARY;
+}
+
+/***********************************************************************
+Adds every trigram, bigram and letter of a word to the counters. Chars
+that are not letters count as a word boundary, like score_names() does
+***********************************************************************/
+void count_ngrams(const char *word)
+{
+	int a = SCORE_BOUNDARY; // the 2 letters before the current one
+	int b = SCORE_BOUNDARY;
+
+	for (int i = 0; ; i++)
+	{
+		// the end of the word is counted too, as a boundary symbol
+		int c = (word[i] == '\0') ? SCORE_BOUNDARY : letter_code(word[i]);
+
+		trigram_count[a][b][c]++;
+		bigram_count[b][c]++;
+		unigram_count[c]++;
+
+		if (word[i] == '\0')
+		{
+			break; // end of the word
+		}
+		a = b;
+		b = c;
+	}
+}
+
+/***********************************************************************
+Counts the n-grams of every pair of syllables the generator can use, so
+the scorer rewards names that look like the ones made of our syllables
+***********************************************************************/
+void train_from_rules()
+{
+	char* syllables[(sizeof(syllables_consonant) + sizeof(syllables_vowel)) / sizeof(char*)];
+	int syllables_count = 0;
+	char word[2 * 3 + 1]; // our syllables have 3 letters as much
+
+	for (size_t i = 0; i < sizeof(syllables_consonant) / sizeof(syllables_consonant[0]); i++)
+	{
+		syllables[syllables_count++] = syllables_consonant[i];
+	}
+	for (size_t i = 0; i < sizeof(syllables_vowel) / sizeof(syllables_vowel[0]); i++)
+	{
+		syllables[syllables_count++] = syllables_vowel[i];
+	}
+
+	for (int i = 0; i < syllables_count; i++)
+	{
+		for (int j = 0; j < syllables_count; j++)
+		{
+			snprintf(word, sizeof(word), "%s%s", syllables[i], syllables[j]);
+			count_ngrams(word);
+		}
+	}
+}
+
+/***********************************************************************
+Counts the n-grams of every name of a corpus file, one name per line.
+Returns the number of names read, or -1 if the file can't be opened
+***********************************************************************/
+int train_from_corpus(const char *corpus_path)
+{
+	FILE *corpus = fopen(corpus_path, "r");
+	char line[256];
+	int words = 0;
+
+	if (corpus == NULL)
+	{
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), corpus) != NULL)
+	{
+		line[strcspn(line, "\r\n")] = '\0'; // cut the line end
+
+		if (line[0] != '\0')
+		{
+			count_ngrams(line);
+			words++;
+		}
+	}
+
+	fclose(corpus);
+	return words;
+}
+
+/***********************************************************************
+Turns the n-gram counters into the trigram log-probability table.
+
+ * Every probability is smoothed with +1 to every counter, so unseen
+ * n-grams are unlikely but still possible, and then the trigram,
+ * bigram and letter probabilities are mixed as 60%, 30% and 10%.
+***********************************************************************/
+void build_trigram_table()
+{
+	unsigned int unigram_total = 0;
+
+	for (int c = 0; c < SCORE_SYMBOLS; c++)
+	{
+		unigram_total += unigram_count[c];
+	}
+
+	for (int a = 0; a < SCORE_SYMBOLS; a++)
+	{
+		for (int b = 0; b < SCORE_SYMBOLS; b++)
+		{
+			unsigned int trigram_total = 0; // how many times "ab" had a next letter
+			unsigned int bigram_total = 0; // how many times "b" had a next letter
+
+			for (int c = 0; c < SCORE_SYMBOLS; c++)
+			{
+				trigram_total += trigram_count[a][b][c];
+				bigram_total += bigram_count[b][c];
+			}
+
+			for (int c = 0; c < SCORE_SYMBOLS; c++)
+			{
+				double p3 = (trigram_count[a][b][c] + 1.0) / (trigram_total + SCORE_SYMBOLS);
+				double p2 = (bigram_count[b][c] + 1.0) / (bigram_total + SCORE_SYMBOLS);
+				double p1 = (unigram_count[c] + 1.0) / (unigram_total + SCORE_SYMBOLS);
+
+				trigram_logp[(a * SCORE_SYMBOLS + b) * SCORE_SYMBOLS + c] =
+							(float)log(0.6 * p3 + 0.3 * p2 + 0.1 * p1);
+			}
+		}
+	}
+}
+
+/***********************************************************************
+Trains the scorer from a corpus file, or from the generator's own rules
+if there is no corpus (NULL) or it can't be read
+***********************************************************************/
+void train_scorer(const char *corpus_path)
+{
+	memset(trigram_count, 0, sizeof(trigram_count));
+	memset(bigram_count, 0, sizeof(bigram_count));
+	memset(unigram_count, 0, sizeof(unigram_count));
+
+	if (corpus_path == NULL || train_from_corpus(corpus_path) <= 0)
+	{
+		if (corpus_path != NULL)
+		{
+			printf("WARNING: couldn't read any name from '%s', using the generator's rules\n", corpus_path);
+		}
+		train_from_rules();
+	}
+
+	build_trigram_table();
+}
+
+#ifdef SCORE_AVX2
+/***********************************************************************
+Scores the names 8 at once with AVX2 gathers, only built for this
+function so the program still runs on CPUs without AVX2.
+Returns how many names were scored, always a multiple of 8
+***********************************************************************/
+__attribute__((target("avx2")))
+int score_names_avx2(const unsigned char *codes, const int *lengths, int count, float *scores)
+{
+	int n = 0;
+
+	// 8 names at once: gather 4 codes of every name, keep the first 3 as
+	// the trigram, and gather its log-probability from the table
+	const __m256i lane_offsets = _mm256_setr_epi32(0, SCORE_CODE_STRIDE,
+									2 * SCORE_CODE_STRIDE, 3 * SCORE_CODE_STRIDE,
+									4 * SCORE_CODE_STRIDE, 5 * SCORE_CODE_STRIDE,
+									6 * SCORE_CODE_STRIDE, 7 * SCORE_CODE_STRIDE);
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+	const __m256i symbols = _mm256_set1_epi32(SCORE_SYMBOLS);
+
+	for (; n + 8 <= count; n += 8)
+	{
+		const unsigned char *base = codes + (size_t)n * SCORE_CODE_STRIDE;
+		// a name of length L has L + 1 trigrams, the last one ends in "$"
+		__m256i trigrams = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(lengths + n)),
+									_mm256_set1_epi32(1));
+		__m256 sum = _mm256_setzero_ps();
+		int max_length = 0;
+
+		for (int i = n; i < n + 8; i++)
+		{
+			if (lengths[i] > max_length)
+			{
+				max_length = lengths[i];
+			}
+		}
+
+		for (int p = 0; p <= max_length; p++)
+		{
+			// names shorter than p are done, don't add anything to them
+			__m256i active = _mm256_cmpgt_epi32(trigrams, _mm256_set1_epi32(p));
+			__m256i window = _mm256_i32gather_epi32((const int*)(base + p), lane_offsets, 1);
+			__m256i a = _mm256_and_si256(window, byte_mask);
+			__m256i b = _mm256_and_si256(_mm256_srli_epi32(window, 8), byte_mask);
+			__m256i c = _mm256_and_si256(_mm256_srli_epi32(window, 16), byte_mask);
+			__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(
+									_mm256_add_epi32(_mm256_mullo_epi32(a, symbols), b), symbols), c);
+
+			sum = _mm256_add_ps(sum, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), trigram_logp,
+									index, _mm256_castsi256_ps(active), 4));
+		}
+
+		_mm256_storeu_ps(scores + n, _mm256_div_ps(sum, _mm256_cvtepi32_ps(trigrams)));
+	}
+
+	return n;
+}
+#endif
+
+/***********************************************************************
+Scores a packed batch of names, one name every NAME_BUFFER_SIZE chars,
+and stores the score of every name in scores[]
+***********************************************************************/
+void score_names(const char *names, int count, float *scores)
+{
+	// every name as symbol codes "^^name$", one every SCORE_CODE_STRIDE
+	// bytes, so a trigram is always 3 consecutive bytes
+	unsigned char* codes = (unsigned char*)malloc((size_t)count * SCORE_CODE_STRIDE);
+	int* lengths = (int*)malloc((size_t)count * sizeof(int));
+	int n = 0;
+
+	if (codes == NULL || lengths == NULL)
+	{
+		printf("ERROR: couldn't assign memory for scoring the names\n");
+		exit(1);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const char *name = names + (size_t)i * NAME_BUFFER_SIZE;
+		unsigned char *code = codes + (size_t)i * SCORE_CODE_STRIDE;
+		int length = 0;
+
+		memset(code, SCORE_BOUNDARY, SCORE_CODE_STRIDE);
+		while (length < NAME_BUFFER_SIZE - 1 && name[length] != '\0')
+		{
+			code[2 + length] = letter_code(name[length]);
+			length++;
+		}
+		lengths[i] = length;
+	}
+
+#ifdef SCORE_AVX2
+	if (__builtin_cpu_supports("avx2"))
+	{
+		n = score_names_avx2(codes, lengths, count, scores);
+	}
+#endif
+
+	// the names that didn't fill a group of 8, or every name without AVX2
+	for (; n < count; n++)
+	{
+		const unsigned char *code = codes + (size_t)n * SCORE_CODE_STRIDE;
+		float sum = 0.0f;
+
+		for (int p = 0; p <= lengths[n]; p++)
+		{
+			sum += trigram_logp[(code[p] * SCORE_SYMBOLS + code[p + 1]) * SCORE_SYMBOLS + code[p + 2]];
+		}
+		scores[n] = sum / (lengths[n] + 1);
+	}
+
+	free(lengths);
+	free(codes);
+}
+
+/***********************************************************************
+Removes the repeated names of a packed batch, so the best ones are not
+all the same name. Returns how many different names are left at the
+start of the batch, in the same order they were generated
+***********************************************************************/
+int remove_repeated_names(char *names, int count)
+{
+	// open addressing hash table with the position of every kept name,
+	// at least twice as big as the batch so it never gets full
+	size_t table_size = 1;
+	int* table;
+	int kept = 0;
+
+	while (table_size < 2 * (size_t)count)
+	{
+		table_size *= 2;
+	}
+
+	table = (int*)malloc(table_size * sizeof(int));
+	if (table == NULL)
+	{
+		printf("ERROR: couldn't assign memory for removing repeated names\n");
+		exit(1);
+	}
+	memset(table, -1, table_size * sizeof(int)); // -1 means empty
+
+	for (int i = 0; i < count; i++)
+	{
+		char *name = names + (size_t)i * NAME_BUFFER_SIZE;
+		unsigned int hash = 2166136261u; // FNV-1a hash of the name
+		size_t slot;
+
+		for (int j = 0; name[j] != '\0'; j++)
+		{
+			hash = (hash ^ (unsigned char)name[j]) * 16777619u;
+		}
+
+		// look for the name, or for an empty slot where to keep it
+		for (slot = hash & (table_size - 1); table[slot] != -1; slot = (slot + 1) & (table_size - 1))
+		{
+			if (strcmp(names + (size_t)table[slot] * NAME_BUFFER_SIZE, name) == 0)
+			{
+				break; // we already have this name
+			}
+		}
+
+		if (table[slot] == -1)
+		{
+			memmove(names + (size_t)kept * NAME_BUFFER_SIZE, name, NAME_BUFFER_SIZE);
+			table[slot] = kept;
+			kept++;
+		}
+	}
+
+	free(table);
+	return kept;
+}
+
+/***********************************************************************
+Partial select: moves the "best" highest scores to the first positions
+of the array, in any order, without sorting the rest of it
+***********************************************************************/
+void select_best_names(struct scored_name *scored, int count, int best)
+{
+	int left = 0;
+	int right = count - 1;
+
+	while (left < right)
+	{
+		// split around the middle score, higher scores go to the left
+		float pivot = scored[left + (right - left) / 2].score;
+		int i = left;
+		int j = right;
+
+		while (i <= j)
+		{
+			while (scored[i].score > pivot)
+			{
+				i++;
+			}
+			while (scored[j].score < pivot)
+			{
+				j--;
+			}
+			if (i <= j)
+			{
+				struct scored_name tmp = scored[i];
+				scored[i] = scored[j];
+				scored[j] = tmp;
+				i++;
+				j--;
+			}
+		}
+
+		// keep splitting only the side where the best-th position is
+		if (best - 1 <= j)
+		{
+			right = j;
+		}
+		else if (best - 1 >= i)
+		{
+			left = i;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/***********************************************************************
+Compares 2 scored names for qsort(), the highest score goes first
+***********************************************************************/
+int compare_scored_names(const void *first, const void *second)
+{
+	float a = ((const struct scored_name*)first)->score;
+	float b = ((const struct scored_name*)second)->score;
+
+	return (a < b) - (a > b);
+}
+
+/***********************************************************************
+Generates "count" names and prints the "best" most pronounceable ones,
+without repeating any name
+***********************************************************************/
+void generate_best_names(int count, int best, const char *corpus_path)
+{
+	char* names = (char*)malloc((size_t)count * NAME_BUFFER_SIZE * sizeof(char));
+	float* scores = (float*)malloc((size_t)count * sizeof(float));
+	struct scored_name* scored = (struct scored_name*)malloc((size_t)count * sizeof(struct scored_name));
+
+	if (names == NULL || scores == NULL || scored == NULL)
+	{
+		printf("ERROR: couldn't assign memory for the names batch\n");
+		exit(1);
+	}
+
+	// 1 line for every step of every name would bury the result
+	debug_enabled = false;
+
+	train_scorer(corpus_path);
+
+	// Initialize random numbers' seed only once for the whole batch
+	srand(time(NULL));
+
+	for (int i = 0; i < count; i++)
+	{
+		build_name(names + (size_t)i * NAME_BUFFER_SIZE);
+	}
+
+	int different = remove_repeated_names(names, count);
+
+	if (best > different)
+	{
+		best = different;
+	}
+
+	score_names(names, different, scores);
+
+	for (int i = 0; i < different; i++)
+	{
+		scored[i].score = scores[i];
+		scored[i].index = i;
+	}
+
+	select_best_names(scored, different, best);
+	qsort(scored, best, sizeof(struct scored_name), compare_scored_names); // only the best ones
+
+	printf("\n\tBEST %d OF %d GENERATED NAMES (%d DIFFERENT):\n", best, count, different);
+	for (int i = 0; i < best; i++)
+	{
+		printf("\t%s\t(%.3f)\n", names + (size_t)scored[i].index * NAME_BUFFER_SIZE, scored[i].score);
+	}
+
+	free(scored);
+	free(scores);
+	free(names);
+}
+
 /***********************************************************************
 Clear any trash inside buffer
 
@@ -639,11 +1161,29 @@ int get_user_input() //(char *fun_player_action)
     //getchar(); // clean buffer
 }
 
-int main(void)
+int main(int argc, char *argv[])
 {
 	//char player_action;
 	//srand(time(NULL));
 
+	// batch mode: Player_name_generator N K [corpus]
+	// generates N names and prints the K most pronounceable ones
+	if (argc >= 2)
+	{
+		int count = (argc >= 3) ? atoi(argv[1]) : 0;
+		int best = (argc >= 3) ? atoi(argv[2]) : 0;
+
+		if (count <= 0 || best <= 0)
+		{
+			printf("Usage: %s [N K [corpus]]\n", argv[0]);
+			printf("Generates N names and prints the K most pronounceable ones\n");
+			return 1;
+		}
+
+		generate_best_names(count, best, (argc >= 4) ? argv[3] : NULL);
+		return 0;
+	}
+
 	do
 	{
 		generate_name();